@@ -23,6 +23,7 @@
       'sources': [
         'src/node_fontnik.cpp',
         'src/glyphs.cpp',
+        'src/mapped_file.cpp',
         'vendor/agg/src/agg_curves.cpp',
         '<(SHARED_INTERMEDIATE_DIR)/glyphs.pb.cc'
       ],
@@ -1,5 +1,6 @@
 // fontnik
 #include "glyphs.hpp"
+#include "mapped_file.hpp"
 
 // node
 #include <node_buffer.h>
@@ -17,8 +18,15 @@
 #include <boost/geometry/index/rtree.hpp>
 #pragma GCC diagnostic pop
 
+// zlib
+#include <zlib.h>
+
 // std
+#include <algorithm> // std::sort, std::unique
+#include <atomic>
 #include <cmath> // std::sqrt
+#include <cstdio> // std::snprintf
+#include <memory> // std::shared_ptr
 
 namespace bg = boost::geometry;
 namespace bgm = bg::model;
@@ -34,10 +42,27 @@ typedef bgi::rtree<SegmentValue, bgi::rstar<16>> Tree;
 namespace node_fontnik
 {
 
+// Glyph rendering parameters shared by range and hashes, so outline hashes
+// change whenever the rendered output would. sdf_radius is the search radius
+// in pixels for the distance field.
+const int sdf_size = 24;
+const int sdf_buffer = 3;
+const float sdf_cutoff = 0.25;
+const int sdf_radius = 8;
+
+bool MeasureGlyph(glyph_info &glyph,
+                  int buffer,
+                  FT_Face ft_face,
+                  Rings &rings);
+
 struct FaceMetadata {
     std::string family_name;
     std::string style_name;
     std::vector<int> points;
+    FaceMetadata() :
+        family_name(),
+        style_name(),
+        points() {}
     FaceMetadata(std::string const& _family_name,
                  std::string const& _style_name,
                  std::vector<int> && _points) :
@@ -50,79 +75,222 @@ struct FaceMetadata {
         points(std::move(_points)) {}
 };
 
-struct LoadBaton {
+// Font source and per-face bookkeeping shared by the load, range and hashes
+// batons. Derived batons set request.data to themselves.
+struct FontBaton {
     Nan::Persistent<v8::Function> callback;
     Nan::Persistent<v8::Object> buffer;
-    const char * font_data;
+    const char* font_data;
     std::size_t font_size;
+    std::string font_path;
+    std::shared_ptr<MappedFile> font_file;
     std::string error_name;
-    std::vector<FaceMetadata> faces;
+    const char* open_error;
+    std::vector<int> face_indices;
+    std::vector<std::string> face_errors;
+    std::atomic<std::size_t> faces_remaining;
+    std::size_t faces_pending;
     uv_work_t request;
-    LoadBaton(v8::Local<v8::Object> buf,
-              v8::Local<v8::Value> cb) :
-        font_data(node::Buffer::Data(buf)),
-        font_size(node::Buffer::Length(buf)),
+    FontBaton(v8::Local<v8::Value> font,
+              v8::Local<v8::Value> cb,
+              const char* _open_error,
+              std::vector<int> && _face_indices) :
+        font_data(nullptr),
+        font_size(0),
+        font_path(),
+        font_file(),
         error_name(),
-        faces(),
+        open_error(_open_error),
+        face_indices(std::move(_face_indices)),
+        face_errors(),
+        faces_remaining(0),
+        faces_pending(0),
         request() {
-            request.data = this;
             callback.Reset(cb.As<v8::Function>());
-            buffer.Reset(buf.As<v8::Object>());
+            if (font->IsString()) {
+                font_path = *Nan::Utf8String(font);
+            } else {
+                font_data = node::Buffer::Data(font);
+                font_size = node::Buffer::Length(font);
+                buffer.Reset(font.As<v8::Object>());
+            }
         }
-    ~LoadBaton() {
+    ~FontBaton() {
         callback.Reset();
         buffer.Reset();
     }
 };
 
-struct RangeBaton {
-    Nan::Persistent<v8::Function> callback;
-    Nan::Persistent<v8::Object> buffer;
-    const char* font_data;
-    std::size_t font_size;
-    std::string error_name;
+struct LoadBaton : FontBaton {
+    std::vector<FaceMetadata> faces;
+    LoadBaton(v8::Local<v8::Value> font,
+              v8::Local<v8::Value> cb,
+              std::vector<int> && _face_indices) :
+        FontBaton(font, cb, "could not open font file", std::move(_face_indices)),
+        faces() {
+            request.data = this;
+        }
+};
+
+enum class RangeEncoding {
+    none,
+    gzip,
+    deflate
+};
+
+struct RangeBaton : FontBaton {
     std::uint32_t start;
     std::uint32_t end;
+    RangeEncoding encoding;
+    bool metrics_only;
     std::vector<std::uint32_t> chars;
+    std::vector<llmr::glyphs::fontstack> stacks;
     std::string message;
-    uv_work_t request;
-    RangeBaton(v8::Local<v8::Object> buf,
+    RangeBaton(v8::Local<v8::Value> font,
                v8::Local<v8::Value> cb,
                std::uint32_t _start,
-               std::uint32_t _end) :
-        font_data(node::Buffer::Data(buf)),
-        font_size(node::Buffer::Length(buf)),
-        error_name(),
+               std::uint32_t _end,
+               RangeEncoding _encoding,
+               bool _metrics_only,
+               std::vector<int> && _face_indices,
+               std::vector<std::uint32_t> && _chars) :
+        FontBaton(font, cb, "could not open font", std::move(_face_indices)),
         start(_start),
         end(_end),
-        chars(),
-        message(),
-        request() {
+        encoding(_encoding),
+        metrics_only(_metrics_only),
+        chars(std::move(_chars)),
+        stacks(),
+        message() {
             request.data = this;
-            callback.Reset(cb.As<v8::Function>());
-            buffer.Reset(buf.As<v8::Object>());
         }
-    ~RangeBaton() {
-        callback.Reset();
-        buffer.Reset();
-    }
 };
 
+struct FaceHashes {
+    std::string family_name;
+    std::string style_name;
+    std::vector<std::pair<std::uint32_t, std::string>> glyphs;
+    FaceHashes() :
+        family_name(),
+        style_name(),
+        glyphs() {}
+};
+
+struct HashBaton : FontBaton {
+    std::uint32_t start;
+    std::uint32_t end;
+    std::vector<FaceHashes> faces;
+    HashBaton(v8::Local<v8::Value> font,
+              v8::Local<v8::Value> cb,
+              std::uint32_t _start,
+              std::uint32_t _end,
+              std::vector<int> && _face_indices) :
+        FontBaton(font, cb, "could not open font", std::move(_face_indices)),
+        start(_start),
+        end(_end),
+        faces() {
+            request.data = this;
+        }
+};
+
+// Returns an error message unless font is a font buffer or a file path.
+const char* CheckFontOption(v8::Local<v8::Value> font)
+{
+    if (font->IsString()) {
+        if (Nan::Utf8String(font).length() == 0) {
+            return "Font path must be a non-empty string";
+        }
+        return nullptr;
+    }
+    if (!font->IsObject()) {
+        return "Font buffer is not an object";
+    }
+    v8::Local<v8::Object> obj = font->ToObject();
+    if (obj->IsNull() || obj->IsUndefined() || !node::Buffer::HasInstance(obj)) {
+        return "First argument must be a font buffer";
+    }
+    return nullptr;
+}
+
+bool ParseFaces(v8::Local<v8::Value> faces, std::vector<int> & face_indices)
+{
+    if (faces->IsUndefined()) return true;
+    if (!faces->IsArray()) return false;
+    v8::Local<v8::Array> js_faces = faces.As<v8::Array>();
+    // An empty list would otherwise fall through to "every face".
+    if (js_faces->Length() == 0) return false;
+    for (std::uint32_t i = 0; i < js_faces->Length(); ++i) {
+        v8::Local<v8::Value> face = js_faces->Get(i);
+        if (!face->IsUint32() || face->Uint32Value() > 65535) return false;
+        face_indices.emplace_back(face->Uint32Value());
+    }
+    // Faces are always processed and returned in collection order.
+    std::sort(face_indices.begin(), face_indices.end());
+    face_indices.erase(std::unique(face_indices.begin(), face_indices.end()), face_indices.end());
+    return true;
+}
+
+bool ParseEncoding(v8::Local<v8::Value> encoding, RangeEncoding & range_encoding)
+{
+    if (encoding->IsUndefined()) return true;
+    std::string encoding_name;
+    if (encoding->IsString()) {
+        encoding_name = *Nan::Utf8String(encoding);
+    }
+    if (encoding_name == "gzip") {
+        range_encoding = RangeEncoding::gzip;
+    } else if (encoding_name == "deflate") {
+        range_encoding = RangeEncoding::deflate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Returns an error message unless start and end form a valid 0-65535 range.
+const char* CheckRangeOptions(v8::Local<v8::Value> start, v8::Local<v8::Value> end)
+{
+    if (!start->IsNumber() || start->IntegerValue() < 0) {
+        return "option `start` must be a number from 0-65535";
+    }
+    if (!end->IsNumber() || end->IntegerValue() > 65535) {
+        return "option `end` must be a number from 0-65535";
+    }
+    if (end->IntegerValue() < start->IntegerValue()) {
+        return "`start` must be less than or equal to `end`";
+    }
+    return nullptr;
+}
+
 NAN_METHOD(Load) {
     // Validate arguments.
-    if (!info[0]->IsObject()) {
-        return Nan::ThrowTypeError("First argument must be a font buffer");
+    if (const char* font_error = CheckFontOption(info[0])) {
+        // Paths share range's message; anything else keeps load's own.
+        return Nan::ThrowTypeError(info[0]->IsString() ? font_error : "First argument must be a font buffer or file path");
     }
-    v8::Local<v8::Object> obj = info[0]->ToObject();
-    if (obj->IsNull() || obj->IsUndefined() || !node::Buffer::HasInstance(obj)) {
-        return Nan::ThrowTypeError("First argument must be a font buffer");
+
+    // Options are optional: load(font, [options], callback). Extra arguments
+    // after a callback are ignored, and undefined or null options are skipped.
+    std::vector<int> face_indices;
+    int callback_index = 1;
+    if (info.Length() > 2 && !info[1]->IsFunction()) {
+        callback_index = 2;
+        if (!info[1]->IsUndefined() && !info[1]->IsNull()) {
+            if (!info[1]->IsObject()) {
+                return Nan::ThrowTypeError("Second argument must be an object of options");
+            }
+            v8::Local<v8::Object> options = info[1].As<v8::Object>();
+            if (!ParseFaces(options->Get(Nan::New<v8::String>("faces").ToLocalChecked()), face_indices)) {
+                return Nan::ThrowTypeError("option `faces` must be an array of face indices from 0-65535");
+            }
+        }
     }
 
-    if (info.Length() < 2 || !info[1]->IsFunction()) {
+    if (info.Length() <= callback_index || !info[callback_index]->IsFunction()) {
         return Nan::ThrowTypeError("Callback must be a function");
     }
 
-    LoadBaton* baton = new LoadBaton(obj,info[1]);
+    LoadBaton* baton = new LoadBaton(info[0],info[callback_index],std::move(face_indices));
     uv_queue_work(uv_default_loop(), &baton->request, LoadAsync, (uv_after_work_cb)AfterLoad);
 }
 
@@ -133,41 +301,138 @@ NAN_METHOD(Range) {
     }
 
     v8::Local<v8::Object> options = info[0].As<v8::Object>();
-    v8::Local<v8::Value> font_buffer = options->Get(Nan::New<v8::String>("font").ToLocalChecked());
-    if (!font_buffer->IsObject()) {
-        return Nan::ThrowTypeError("Font buffer is not an object");
+    v8::Local<v8::Value> font = options->Get(Nan::New<v8::String>("font").ToLocalChecked());
+    if (const char* font_error = CheckFontOption(font)) {
+        return Nan::ThrowTypeError(font_error);
     }
-    v8::Local<v8::Object> obj = font_buffer->ToObject();
     v8::Local<v8::Value> start = options->Get(Nan::New<v8::String>("start").ToLocalChecked());
     v8::Local<v8::Value> end = options->Get(Nan::New<v8::String>("end").ToLocalChecked());
-
-    if (obj->IsNull() || obj->IsUndefined() || !node::Buffer::HasInstance(obj)) {
-        return Nan::ThrowTypeError("First argument must be a font buffer");
+    if (const char* range_error = CheckRangeOptions(start, end)) {
+        return Nan::ThrowTypeError(range_error);
     }
 
-    if (!start->IsNumber() || start->IntegerValue() < 0) {
-        return Nan::ThrowTypeError("option `start` must be a number from 0-65535");
+    RangeEncoding range_encoding = RangeEncoding::none;
+    if (!ParseEncoding(options->Get(Nan::New<v8::String>("encoding").ToLocalChecked()), range_encoding)) {
+        return Nan::ThrowTypeError("option `encoding` must be 'gzip' or 'deflate'");
     }
 
-    if (!end->IsNumber() || end->IntegerValue() > 65535) {
-        return Nan::ThrowTypeError("option `end` must be a number from 0-65535");
+    v8::Local<v8::Value> metrics_only = options->Get(Nan::New<v8::String>("metrics_only").ToLocalChecked());
+    if (!metrics_only->IsUndefined() && !metrics_only->IsBoolean()) {
+        return Nan::ThrowTypeError("option `metrics_only` must be a boolean");
     }
 
-    if (end->IntegerValue() < start->IntegerValue()) {
-        return Nan::ThrowTypeError("`start` must be less than or equal to `end`");
+    std::vector<int> face_indices;
+    if (!ParseFaces(options->Get(Nan::New<v8::String>("faces").ToLocalChecked()), face_indices)) {
+        return Nan::ThrowTypeError("option `faces` must be an array of face indices from 0-65535");
     }
 
     if (info.Length() < 2 || !info[1]->IsFunction()) {
         return Nan::ThrowTypeError("Callback must be a function");
     }
 
-    RangeBaton* baton = new RangeBaton(obj,
+    // An empty chars list makes RangeAsync cover every point from start to end.
+    RangeBaton* baton = new RangeBaton(font,
                                        info[1],
                                        start->IntegerValue(),
-                                       end->IntegerValue());
+                                       end->IntegerValue(),
+                                       range_encoding,
+                                       metrics_only->IsTrue(),
+                                       std::move(face_indices),
+                                       std::vector<std::uint32_t>());
     uv_queue_work(uv_default_loop(), &baton->request, RangeAsync, (uv_after_work_cb)AfterRange);
 }
 
+NAN_METHOD(Glyphs) {
+    // Validate arguments.
+    if (info.Length() < 1 || !info[0]->IsObject()) {
+        return Nan::ThrowTypeError("First argument must be an object of options");
+    }
+
+    v8::Local<v8::Object> options = info[0].As<v8::Object>();
+    v8::Local<v8::Value> font = options->Get(Nan::New<v8::String>("font").ToLocalChecked());
+    if (const char* font_error = CheckFontOption(font)) {
+        return Nan::ThrowTypeError(font_error);
+    }
+
+    v8::Local<v8::Value> codepoints = options->Get(Nan::New<v8::String>("codepoints").ToLocalChecked());
+    if (!codepoints->IsArray() || codepoints.As<v8::Array>()->Length() == 0) {
+        return Nan::ThrowTypeError("option `codepoints` must be a non-empty array of numbers from 0-65535");
+    }
+
+    v8::Local<v8::Array> js_codepoints = codepoints.As<v8::Array>();
+    std::vector<std::uint32_t> chars;
+    chars.reserve(js_codepoints->Length());
+    for (std::uint32_t i = 0; i < js_codepoints->Length(); ++i) {
+        v8::Local<v8::Value> point = js_codepoints->Get(i);
+        if (!point->IsUint32() || point->Uint32Value() > 65535) {
+            return Nan::ThrowTypeError("option `codepoints` must be a non-empty array of numbers from 0-65535");
+        }
+        chars.emplace_back(point->Uint32Value());
+    }
+    std::sort(chars.begin(), chars.end());
+    chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+
+    RangeEncoding range_encoding = RangeEncoding::none;
+    if (!ParseEncoding(options->Get(Nan::New<v8::String>("encoding").ToLocalChecked()), range_encoding)) {
+        return Nan::ThrowTypeError("option `encoding` must be 'gzip' or 'deflate'");
+    }
+
+    std::vector<int> face_indices;
+    if (!ParseFaces(options->Get(Nan::New<v8::String>("faces").ToLocalChecked()), face_indices)) {
+        return Nan::ThrowTypeError("option `faces` must be an array of face indices from 0-65535");
+    }
+
+    if (info.Length() < 2 || !info[1]->IsFunction()) {
+        return Nan::ThrowTypeError("Callback must be a function");
+    }
+
+    std::uint32_t start = chars.front();
+    std::uint32_t end = chars.back();
+    RangeBaton* baton = new RangeBaton(font,
+                                       info[1],
+                                       start,
+                                       end,
+                                       range_encoding,
+                                       false,
+                                       std::move(face_indices),
+                                       std::move(chars));
+    uv_queue_work(uv_default_loop(), &baton->request, RangeAsync, (uv_after_work_cb)AfterRange);
+}
+
+NAN_METHOD(Hashes) {
+    // Validate arguments.
+    if (info.Length() < 1 || !info[0]->IsObject()) {
+        return Nan::ThrowTypeError("First argument must be an object of options");
+    }
+
+    v8::Local<v8::Object> options = info[0].As<v8::Object>();
+    v8::Local<v8::Value> font = options->Get(Nan::New<v8::String>("font").ToLocalChecked());
+    if (const char* font_error = CheckFontOption(font)) {
+        return Nan::ThrowTypeError(font_error);
+    }
+    v8::Local<v8::Value> start = options->Get(Nan::New<v8::String>("start").ToLocalChecked());
+    v8::Local<v8::Value> end = options->Get(Nan::New<v8::String>("end").ToLocalChecked());
+    if (const char* range_error = CheckRangeOptions(start, end)) {
+        return Nan::ThrowTypeError(range_error);
+    }
+
+    std::vector<int> face_indices;
+    if (!ParseFaces(options->Get(Nan::New<v8::String>("faces").ToLocalChecked()), face_indices)) {
+        return Nan::ThrowTypeError("option `faces` must be an array of face indices from 0-65535");
+    }
+
+    if (info.Length() < 2 || !info[1]->IsFunction()) {
+        return Nan::ThrowTypeError("Callback must be a function");
+    }
+
+    HashBaton* baton = new HashBaton(font,
+                                     info[1],
+                                     start->IntegerValue(),
+                                     end->IntegerValue(),
+                                     std::move(face_indices));
+    uv_queue_work(uv_default_loop(), &baton->request, HashesAsync, (uv_after_work_cb)AfterHashes);
+}
+
 struct ft_library_guard {
     ft_library_guard(FT_Library * lib) :
         library_(lib) {}
@@ -180,57 +445,203 @@ struct ft_library_guard {
     FT_Library * library_;
 };
 
-void LoadAsync(uv_work_t* req) {
-    LoadBaton* baton = static_cast<LoadBaton*>(req->data);
+// Maps the font file for batons given a path instead of a buffer. The
+// mapping stays alive for as long as the baton holds it.
+bool MapFontFile(FontBaton* baton)
+{
+    if (baton->font_path.empty()) return true;
+
+    baton->font_file = MappedFile::open(baton->font_path);
+    if (!baton->font_file) {
+        baton->error_name = std::string("could not open font file ") + baton->font_path;
+        return false;
+    }
+    baton->font_data = baton->font_file->data();
+    baton->font_size = baton->font_file->size();
+    return true;
+}
 
+// Fills in face_indices with every face in the font if it is empty, or
+// checks that the requested faces exist.
+bool ResolveFaces(const char* font_data,
+                  std::size_t font_size,
+                  std::vector<int> & face_indices,
+                  std::string const& open_error,
+                  std::string & error_name)
+{
     FT_Library library = nullptr;
     ft_library_guard library_guard(&library);
     FT_Error error = FT_Init_FreeType(&library);
     if (error) {
         /* LCOV_EXCL_START */
-        baton->error_name = std::string("could not open FreeType library");
-        return;
+        error_name = std::string("could not open FreeType library");
+        return false;
         /* LCOV_EXCL_END */
     }
+
+    // A face index of -1 only reads the number of faces in the font.
     FT_Face ft_face = 0;
-    int num_faces = 0;
-    for ( int i = 0; ft_face == 0 || i < num_faces; ++i )
-    {
-        FT_Error face_error = FT_New_Memory_Face(library, reinterpret_cast<FT_Byte const*>(baton->font_data), static_cast<FT_Long>(baton->font_size), i, &ft_face);
-        if (face_error) {
-            baton->error_name = std::string("could not open font file");
-            return;
-        }
-        std::set<int> points;
-        if (num_faces == 0)
-            num_faces = ft_face->num_faces;
-        FT_ULong charcode;
-        FT_UInt gindex;
-        charcode = FT_Get_First_Char(ft_face, &gindex);
-        while (gindex != 0) {
-            charcode = FT_Get_Next_Char(ft_face, charcode, &gindex);
-            if (charcode != 0) points.emplace(charcode);
+    FT_Error face_error = FT_New_Memory_Face(library, reinterpret_cast<FT_Byte const*>(font_data), static_cast<FT_Long>(font_size), -1, &ft_face);
+    if (face_error) {
+        error_name = open_error;
+        return false;
+    }
+    FT_Long num_faces = ft_face->num_faces;
+    FT_Done_Face(ft_face);
+
+    if (face_indices.empty()) {
+        for (FT_Long i = 0; i < num_faces; ++i) {
+            face_indices.emplace_back(i);
         }
+    } else if (face_indices.back() >= num_faces) {
+        error_name = std::string("font face index out of range");
+        return false;
+    }
+    return true;
+}
 
-        std::vector<int> points_vec(points.begin(), points.end());
+void ProcessFace(LoadBaton* baton, std::size_t slot, FT_Face ft_face);
+void ProcessFace(RangeBaton* baton, std::size_t slot, FT_Face ft_face);
+void ProcessFace(HashBaton* baton, std::size_t slot, FT_Face ft_face);
+void MergeFaces(LoadBaton* baton);
+void MergeFaces(RangeBaton* baton);
+void MergeFaces(HashBaton* baton);
+
+// One face of a collection, processed as its own threadpool request.
+template <typename Baton>
+struct FaceRequest {
+    Baton* baton;
+    std::size_t slot;
+    uv_work_t request;
+    FaceRequest(Baton* _baton, std::size_t _slot) :
+        baton(_baton),
+        slot(_slot),
+        request() {
+            request.data = this;
+        }
+};
 
-        if (ft_face->style_name) {
-            baton->faces.emplace_back(ft_face->family_name, ft_face->style_name, std::move(points_vec));
+// Opens the face for slot with its own FreeType library and face handle and
+// stores its result by slot. Whichever face finishes last merges the
+// results in face order, still on the threadpool.
+template <typename Baton>
+void ProcessFaceSlot(Baton* baton, std::size_t slot)
+{
+    FT_Library library = nullptr;
+    ft_library_guard library_guard(&library);
+    FT_Error error = FT_Init_FreeType(&library);
+    if (error) {
+        /* LCOV_EXCL_START */
+        baton->face_errors[slot] = std::string("could not open FreeType library");
+        /* LCOV_EXCL_END */
+    } else {
+        FT_Face ft_face = 0;
+        FT_Error face_error = FT_New_Memory_Face(library, reinterpret_cast<FT_Byte const*>(baton->font_data), static_cast<FT_Long>(baton->font_size), baton->face_indices[slot], &ft_face);
+        if (face_error) {
+            baton->face_errors[slot] = baton->open_error;
         } else {
-            baton->faces.emplace_back(ft_face->family_name, std::move(points_vec));
+            ProcessFace(baton, slot, ft_face);
+            FT_Done_Face(ft_face);
         }
+    }
 
-        if (ft_face) {
-            FT_Done_Face(ft_face);
+    if (--baton->faces_remaining == 0) {
+        for (auto const& face_error : baton->face_errors) {
+            if (!face_error.empty()) {
+                baton->error_name = face_error;
+                return;
+            }
         }
+        MergeFaces(baton);
+    }
+}
+
+// Called from the resolving worker once face_indices is known. A single
+// face is processed right away; the faces of a collection are left for
+// QueueFaces to spread across the threadpool.
+template <typename Baton>
+void StartFaces(Baton* baton)
+{
+    baton->face_errors.resize(baton->face_indices.size());
+    baton->faces_remaining = baton->face_indices.size();
+    if (baton->face_indices.size() == 1) {
+        ProcessFaceSlot(baton, 0);
+    }
+}
+
+template <typename Baton>
+void FaceAsync(uv_work_t* req)
+{
+    FaceRequest<Baton>* face = static_cast<FaceRequest<Baton>*>(req->data);
+    ProcessFaceSlot(face->baton, face->slot);
+}
+
+template <typename Baton, void (*After)(uv_work_t*)>
+void AfterFace(uv_work_t* req)
+{
+    FaceRequest<Baton>* face = static_cast<FaceRequest<Baton>*>(req->data);
+    Baton* baton = face->baton;
+    delete face;
+    if (--baton->faces_pending == 0) {
+        After(&baton->request);
+    }
+}
+
+// Queues one request per unprocessed face and calls After again once they
+// have all finished. Returns false if there is nothing left to process.
+template <typename Baton, void (*After)(uv_work_t*)>
+bool QueueFaces(Baton* baton)
+{
+    if (!baton->error_name.empty() || baton->faces_remaining == 0) return false;
+
+    baton->faces_pending = baton->face_indices.size();
+    for (std::size_t slot = 0; slot < baton->face_indices.size(); ++slot) {
+        FaceRequest<Baton>* face = new FaceRequest<Baton>(baton, slot);
+        uv_queue_work(uv_default_loop(), &face->request, FaceAsync<Baton>, (uv_after_work_cb)AfterFace<Baton, After>);
     }
+    return true;
+}
+
+void LoadAsync(uv_work_t* req) {
+    LoadBaton* baton = static_cast<LoadBaton*>(req->data);
+
+    if (!MapFontFile(baton)) return;
+
+    if (!ResolveFaces(baton->font_data, baton->font_size, baton->face_indices, baton->open_error, baton->error_name)) return;
+
+    baton->faces.resize(baton->face_indices.size());
+    StartFaces(baton);
 };
 
+void ProcessFace(LoadBaton* baton, std::size_t slot, FT_Face ft_face) {
+    std::set<int> points;
+    FT_ULong charcode;
+    FT_UInt gindex;
+    charcode = FT_Get_First_Char(ft_face, &gindex);
+    while (gindex != 0) {
+        charcode = FT_Get_Next_Char(ft_face, charcode, &gindex);
+        if (charcode != 0) points.emplace(charcode);
+    }
+
+    std::vector<int> points_vec(points.begin(), points.end());
+
+    if (ft_face->style_name) {
+        baton->faces[slot] = FaceMetadata(ft_face->family_name, ft_face->style_name, std::move(points_vec));
+    } else {
+        baton->faces[slot] = FaceMetadata(ft_face->family_name, std::move(points_vec));
+    }
+}
+
+// Faces are already stored in face order.
+void MergeFaces(LoadBaton* baton) {}
+
 void AfterLoad(uv_work_t* req) {
     Nan::HandleScope scope;
 
     LoadBaton* baton = static_cast<LoadBaton*>(req->data);
 
+    if (QueueFaces<LoadBaton, AfterLoad>(baton)) return;
+
     if (!baton->error_name.empty()) {
         v8::Local<v8::Value> argv[1] = { Nan::Error(baton->error_name.c_str()) };
         Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New(baton->callback), 1, argv);
@@ -255,86 +666,148 @@ void AfterLoad(uv_work_t* req) {
     delete baton;
 };
 
-void RangeAsync(uv_work_t* req) {
-    RangeBaton* baton = static_cast<RangeBaton*>(req->data);
+struct zlib_compressor {
+    z_stream stream;
+    bool initialized;
 
-    unsigned array_size = baton->end - baton->start;
-    baton->chars.reserve(array_size);
-    for (unsigned i=baton->start; i <= baton->end; i++) {
-        baton->chars.emplace_back(i);
+    explicit zlib_compressor(int window_bits) :
+        stream(),
+        initialized(false)
+    {
+        initialized = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                   window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
     }
 
-    FT_Library library = nullptr;
-    ft_library_guard library_guard(&library);
-    FT_Error error = FT_Init_FreeType(&library);
-    if (error) {
-        /* LCOV_EXCL_START */
-        baton->error_name = std::string("could not open FreeType library");
-        return;
-        /* LCOV_EXCL_END */
+    ~zlib_compressor()
+    {
+        if (initialized) deflateEnd(&stream);
     }
+};
 
-    FT_Face ft_face = 0;
+// Each threadpool thread keeps its own compressor per encoding and resets it
+// between ranges rather than allocating fresh zlib state for every message.
+// The state is only created the first time a thread uses that encoding.
+zlib_compressor & GzipCompressor()
+{
+    // Adding 16 to the window bits selects a gzip header instead of zlib's.
+    static thread_local zlib_compressor compressor(15 + 16);
+    return compressor;
+}
 
-    llmr::glyphs::glyphs glyphs;
+zlib_compressor & DeflateCompressor()
+{
+    static thread_local zlib_compressor compressor(15);
+    return compressor;
+}
 
-    int num_faces = 0;
-    for ( int i = 0; ft_face == 0 || i < num_faces; ++i )
-    {
-        FT_Error face_error = FT_New_Memory_Face(library, reinterpret_cast<FT_Byte const*>(baton->font_data), static_cast<FT_Long>(baton->font_size), i, &ft_face);
-        if (face_error) {
-            baton->error_name = std::string("could not open font");
-            return;
-        }
+bool CompressMessage(std::string const& input, std::string & output, bool gzip)
+{
+    zlib_compressor & compressor = gzip ? GzipCompressor() : DeflateCompressor();
+    if (!compressor.initialized) return false;
 
-        llmr::glyphs::fontstack *mutable_fontstack = glyphs.add_stacks();
+    z_stream & stream = compressor.stream;
+    if (deflateReset(&stream) != Z_OK) return false;
 
-        if (ft_face->style_name) {
-            mutable_fontstack->set_name(std::string(ft_face->family_name) + " " + std::string(ft_face->style_name));
-        } else {
-            mutable_fontstack->set_name(std::string(ft_face->family_name));
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) return false;
+
+    output.resize(stream.total_out);
+    return true;
+}
+
+void RangeAsync(uv_work_t* req) {
+    RangeBaton* baton = static_cast<RangeBaton*>(req->data);
+
+    if (!MapFontFile(baton)) return;
+
+    if (baton->chars.empty()) {
+        unsigned array_size = baton->end - baton->start;
+        baton->chars.reserve(array_size);
+        for (unsigned i=baton->start; i <= baton->end; i++) {
+            baton->chars.emplace_back(i);
         }
+    }
 
-        mutable_fontstack->set_range(std::to_string(baton->start) + "-" + std::to_string(baton->end));
+    if (!ResolveFaces(baton->font_data, baton->font_size, baton->face_indices, baton->open_error, baton->error_name)) return;
 
-        const double scale_factor = 1.0;
+    baton->stacks.resize(baton->face_indices.size());
+    StartFaces(baton);
+}
 
-        // Set character sizes.
-        double size = 24 * scale_factor;
-        FT_Set_Char_Size(ft_face,0,(FT_F26Dot6)(size * (1<<6)),0,0);
+void ProcessFace(RangeBaton* baton, std::size_t slot, FT_Face ft_face) {
+    llmr::glyphs::fontstack *mutable_fontstack = &baton->stacks[slot];
+
+    if (ft_face->style_name) {
+        mutable_fontstack->set_name(std::string(ft_face->family_name) + " " + std::string(ft_face->style_name));
+    } else {
+        mutable_fontstack->set_name(std::string(ft_face->family_name));
+    }
 
-        for (std::vector<uint32_t>::size_type x = 0; x != baton->chars.size(); x++) {
-            FT_ULong char_code = baton->chars[x];
-            glyph_info glyph;
+    mutable_fontstack->set_range(std::to_string(baton->start) + "-" + std::to_string(baton->end));
 
-            // Get FreeType face from face_ptr.
-            FT_UInt char_index = FT_Get_Char_Index(ft_face, char_code);
+    const double scale_factor = 1.0;
 
-            if (!char_index) continue;
+    // Set character sizes.
+    double size = sdf_size * scale_factor;
+    FT_Set_Char_Size(ft_face,0,(FT_F26Dot6)(size * (1<<6)),0,0);
 
-            glyph.glyph_index = char_index;
-            RenderSDF(glyph, 24, 3, 0.25, ft_face);
+    for (std::vector<uint32_t>::size_type x = 0; x != baton->chars.size(); x++) {
+        FT_ULong char_code = baton->chars[x];
+        glyph_info glyph;
 
-            // Add glyph to fontstack.
-            llmr::glyphs::glyph *mutable_glyph = mutable_fontstack->add_glyphs();
-            mutable_glyph->set_id(char_code);
-            mutable_glyph->set_width(glyph.width);
-            mutable_glyph->set_height(glyph.height);
-            mutable_glyph->set_left(glyph.left);
-            mutable_glyph->set_top(glyph.top - glyph.ascender);
-            mutable_glyph->set_advance(glyph.advance);
+        // Get FreeType face from face_ptr.
+        FT_UInt char_index = FT_Get_Char_Index(ft_face, char_code);
 
-            if (glyph.width > 0) {
-                mutable_glyph->set_bitmap(glyph.bitmap);
-            }
+        if (!char_index) continue;
 
+        glyph.glyph_index = char_index;
+        if (baton->metrics_only) {
+            // Only the outline load and bbox pass; no distance field.
+            Rings rings;
+            MeasureGlyph(glyph, sdf_buffer, ft_face, rings);
+        } else {
+            RenderSDF(glyph, sdf_size, sdf_buffer, sdf_cutoff, ft_face);
         }
-        if (ft_face) {
-            FT_Done_Face(ft_face);
+
+        // Add glyph to fontstack.
+        llmr::glyphs::glyph *mutable_glyph = mutable_fontstack->add_glyphs();
+        mutable_glyph->set_id(char_code);
+        mutable_glyph->set_width(glyph.width);
+        mutable_glyph->set_height(glyph.height);
+        mutable_glyph->set_left(glyph.left);
+        mutable_glyph->set_top(glyph.top - glyph.ascender);
+        mutable_glyph->set_advance(glyph.advance);
+
+        if (!glyph.bitmap.empty()) {
+            mutable_glyph->set_bitmap(glyph.bitmap);
         }
+
+    }
+}
+
+void MergeFaces(RangeBaton* baton) {
+    llmr::glyphs::glyphs glyphs;
+    for (auto & stack : baton->stacks) {
+        glyphs.add_stacks()->Swap(&stack);
     }
 
     baton->message = glyphs.SerializeAsString();
+
+    if (baton->encoding != RangeEncoding::none) {
+        std::string compressed;
+        if (!CompressMessage(baton->message, compressed, baton->encoding == RangeEncoding::gzip)) {
+            /* LCOV_EXCL_START */
+            baton->error_name = std::string("could not compress glyphs");
+            return;
+            /* LCOV_EXCL_END */
+        }
+        baton->message.swap(compressed);
+    }
 }
 
 void AfterRange(uv_work_t* req) {
@@ -342,6 +815,8 @@ void AfterRange(uv_work_t* req) {
 
     RangeBaton* baton = static_cast<RangeBaton*>(req->data);
 
+    if (QueueFaces<RangeBaton, AfterRange>(baton)) return;
+
     if (!baton->error_name.empty()) {
         v8::Local<v8::Value> argv[1] = { Nan::Error(baton->error_name.c_str()) };
         Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New(baton->callback), 1, argv);
@@ -355,6 +830,70 @@ void AfterRange(uv_work_t* req) {
     delete baton;
 };
 
+void HashesAsync(uv_work_t* req) {
+    HashBaton* baton = static_cast<HashBaton*>(req->data);
+
+    if (!MapFontFile(baton)) return;
+
+    if (!ResolveFaces(baton->font_data, baton->font_size, baton->face_indices, baton->open_error, baton->error_name)) return;
+
+    baton->faces.resize(baton->face_indices.size());
+    StartFaces(baton);
+}
+
+void ProcessFace(HashBaton* baton, std::size_t slot, FT_Face ft_face) {
+    FaceHashes & face = baton->faces[slot];
+    face.family_name = ft_face->family_name;
+    if (ft_face->style_name) face.style_name = ft_face->style_name;
+
+    // Outlines are hashed at the same size RangeAsync renders them at.
+    double size = sdf_size;
+    FT_Set_Char_Size(ft_face,0,(FT_F26Dot6)(size * (1<<6)),0,0);
+
+    for (std::uint32_t char_code = baton->start; char_code <= baton->end; char_code++) {
+        FT_UInt char_index = FT_Get_Char_Index(ft_face, char_code);
+        if (!char_index) continue;
+
+        glyph_info glyph;
+        glyph.glyph_index = char_index;
+        face.glyphs.emplace_back(char_code, HashGlyph(glyph, sdf_size, sdf_buffer, sdf_cutoff, ft_face));
+    }
+}
+
+// Faces are already stored in face order.
+void MergeFaces(HashBaton* baton) {}
+
+void AfterHashes(uv_work_t* req) {
+    Nan::HandleScope scope;
+
+    HashBaton* baton = static_cast<HashBaton*>(req->data);
+
+    if (QueueFaces<HashBaton, AfterHashes>(baton)) return;
+
+    if (!baton->error_name.empty()) {
+        v8::Local<v8::Value> argv[1] = { Nan::Error(baton->error_name.c_str()) };
+        Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New(baton->callback), 1, argv);
+    } else {
+        v8::Local<v8::Array> js_faces = Nan::New<v8::Array>(baton->faces.size());
+        unsigned idx = 0;
+        for (auto const& face : baton->faces) {
+            v8::Local<v8::Object> js_face = Nan::New<v8::Object>();
+            js_face->Set(Nan::New("family_name").ToLocalChecked(), Nan::New(face.family_name).ToLocalChecked());
+            if (!face.style_name.empty()) js_face->Set(Nan::New("style_name").ToLocalChecked(), Nan::New(face.style_name).ToLocalChecked());
+            v8::Local<v8::Object> js_glyphs = Nan::New<v8::Object>();
+            for (auto const& glyph : face.glyphs) {
+                js_glyphs->Set(glyph.first, Nan::New(glyph.second).ToLocalChecked());
+            }
+            js_face->Set(Nan::New("glyphs").ToLocalChecked(), js_glyphs);
+            js_faces->Set(idx++,js_face);
+        }
+        v8::Local<v8::Value> argv[2] = { Nan::Null(), js_faces };
+        Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New(baton->callback), 2, argv);
+    }
+
+    delete baton;
+};
+
 struct User {
     Rings rings;
     Points ring;
@@ -525,15 +1064,14 @@ double MinDistanceToLineSegment(const Tree &tree,
     return std::sqrt(sqaured_distance);
 }
 
-void RenderSDF(glyph_info &glyph,
-                     int size,
-                     int buffer,
-                     float cutoff,
-                     FT_Face ft_face)
+// Loads the glyph, fills in its FreeType metrics and decomposes its outline
+// into closed rings. Returns false if the glyph has no outline to render.
+bool LoadGlyphOutline(glyph_info &glyph,
+                      FT_Face ft_face,
+                      Rings &rings)
 {
-
     if (FT_Load_Glyph (ft_face, glyph.glyph_index, FT_LOAD_NO_HINTING)) {
-        return;
+        return false;
     }
 
     int advance = ft_face->glyph->metrics.horiAdvance / 64;
@@ -559,7 +1097,7 @@ void RenderSDF(glyph_info &glyph,
     if (ft_face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
         // Decompose outline into bezier curves and line segments
         FT_Outline outline = ft_face->glyph->outline;
-        if (FT_Outline_Decompose(&outline, &func_interface, &user)) return;
+        if (FT_Outline_Decompose(&outline, &func_interface, &user)) return false;
 
         if (!user.ring.empty()) {
             CloseRing(user.ring);
@@ -567,10 +1105,67 @@ void RenderSDF(glyph_info &glyph,
         }
 
         if (user.rings.empty()) {
-            return;
+            return false;
         }
     } else {
-        return;
+        return false;
+    }
+
+    rings = std::move(user.rings);
+    return true;
+}
+
+// 64 bit FNV-1a, folded over the raw bytes of each value.
+template <typename T>
+void HashValue(std::uint64_t &hash, T const& value)
+{
+    unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&value);
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+std::string HashGlyph(glyph_info &glyph,
+                      int size,
+                      int buffer,
+                      float cutoff,
+                      FT_Face ft_face)
+{
+    Rings rings;
+    LoadGlyphOutline(glyph, ft_face, rings);
+
+    std::uint64_t hash = 14695981039346656037ULL;
+    HashValue(hash, size);
+    HashValue(hash, buffer);
+    HashValue(hash, cutoff);
+    HashValue(hash, sdf_radius);
+    HashValue(hash, glyph.advance);
+    HashValue(hash, glyph.ascender);
+
+    for (const Points &ring : rings) {
+        HashValue(hash, static_cast<std::uint64_t>(ring.size()));
+        for (const Point &point : ring) {
+            HashValue(hash, point.get<0>());
+            HashValue(hash, point.get<1>());
+        }
+    }
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(hex);
+}
+
+// Loads the glyph outline and fills in its bounding box metrics, offsetting
+// the rings into the buffered bitmap space. Returns false if there is no
+// bitmap to render.
+bool MeasureGlyph(glyph_info &glyph,
+                  int buffer,
+                  FT_Face ft_face,
+                  Rings &rings)
+{
+    if (!LoadGlyphOutline(glyph, ft_face, rings)) {
+        return false;
     }
 
     // Calculate the real glyph bbox.
@@ -580,7 +1175,7 @@ void RenderSDF(glyph_info &glyph,
     double bbox_xmax = -std::numeric_limits<double>::infinity(),
            bbox_ymax = -std::numeric_limits<double>::infinity();
 
-    for (const Points &ring : user.rings) {
+    for (const Points &ring : rings) {
         for (const Point &point : ring) {
             if (point.get<0>() > bbox_xmax) bbox_xmax = point.get<0>();
             if (point.get<0>() < bbox_xmin) bbox_xmin = point.get<0>();
@@ -595,25 +1190,39 @@ void RenderSDF(glyph_info &glyph,
     bbox_ymax = std::round(bbox_ymax);
 
     // Offset so that glyph outlines are in the bounding box.
-    for (Points &ring : user.rings) {
+    for (Points &ring : rings) {
         for (Point &point : ring) {
             point.set<0>(point.get<0>() + -bbox_xmin + buffer);
             point.set<1>(point.get<1>() + -bbox_ymin + buffer);
         }
     }
 
-    if (bbox_xmax - bbox_xmin == 0 || bbox_ymax - bbox_ymin == 0) return;
+    if (bbox_xmax - bbox_xmin == 0 || bbox_ymax - bbox_ymin == 0) return false;
 
     glyph.left = bbox_xmin;
     glyph.top = bbox_ymax;
     glyph.width = bbox_xmax - bbox_xmin;
     glyph.height = bbox_ymax - bbox_ymin;
 
+    return true;
+}
+
+void RenderSDF(glyph_info &glyph,
+                     int size,
+                     int buffer,
+                     float cutoff,
+                     FT_Face ft_face)
+{
+    Rings rings;
+    if (!MeasureGlyph(glyph, buffer, ft_face, rings)) {
+        return;
+    }
+
     Tree tree;
     float offset = 0.5;
-    int radius = 8;
+    int radius = sdf_radius;
 
-    for (const Points &ring : user.rings) {
+    for (const Points &ring : rings) {
         auto p1 = ring.begin();
         auto p2 = p1 + 1;
 
@@ -650,7 +1259,7 @@ void RenderSDF(glyph_info &glyph,
             double d = MinDistanceToLineSegment(tree, Point {x + offset, y + offset}, radius) * (256 / radius);
 
             // Invert if point is inside.
-            const bool inside = PolyContainsPoint(user.rings, Point { x + offset, y + offset });
+            const bool inside = PolyContainsPoint(rings, Point { x + offset, y + offset });
             if (inside) {
                 d = -d;
             }
@@ -28,12 +28,24 @@ void AfterLoad(uv_work_t* req);
 NAN_METHOD(Range);
 void RangeAsync(uv_work_t* req);
 void AfterRange(uv_work_t* req);
+NAN_METHOD(Glyphs);
+NAN_METHOD(Hashes);
+void HashesAsync(uv_work_t* req);
+void AfterHashes(uv_work_t* req);
+bool CompressMessage(std::string const& input,
+                     std::string & output,
+                     bool gzip);
 struct glyph_info;
 void RenderSDF(glyph_info &glyph,
                int size,
                int buffer,
                float cutoff,
                FT_Face ft_face);
+std::string HashGlyph(glyph_info &glyph,
+                      int size,
+                      int buffer,
+                      float cutoff,
+                      FT_Face ft_face);
 
 struct glyph_info
 {
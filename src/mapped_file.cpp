@@ -0,0 +1,164 @@
+// fontnik
+#include "mapped_file.hpp"
+
+// std
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace node_fontnik
+{
+
+namespace
+{
+
+// Number of recently opened fonts kept mapped after their last request
+// finishes, so back to back calls for the same fonts do not remap them.
+const std::size_t retained_count = 8;
+
+// Mappings by path. Entries are weak so that dropping a mapping from the
+// retained list unmaps it once no request is using it either.
+std::mutex cache_mutex;
+std::unordered_map<std::string, std::weak_ptr<MappedFile>> cache;
+std::deque<std::shared_ptr<MappedFile>> retained;
+
+struct fd_guard {
+    fd_guard(int fd) :
+        fd_(fd) {}
+
+    ~fd_guard()
+    {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    int fd_;
+};
+
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(std::string const& path)
+{
+    // Mappings dropped from the cache are released here, after the lock.
+    std::vector<std::shared_ptr<MappedFile>> released;
+
+    // Move file to the front of the retained list, evicting the oldest and
+    // any stale mapping of the same path. Must be called with the lock held.
+    auto retain = [&released](std::shared_ptr<MappedFile> const& file) {
+        auto stale = std::remove_if(retained.begin(), retained.end(),
+                                    [&file](std::shared_ptr<MappedFile> const& other) {
+                                        return other->path_ == file->path_;
+                                    });
+        released.insert(released.end(), stale, retained.end());
+        retained.erase(stale, retained.end());
+        retained.push_front(file);
+        while (retained.size() > retained_count) {
+            released.push_back(retained.back());
+            retained.pop_back();
+        }
+    };
+
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(path);
+        if (it != cache.end()) {
+            std::shared_ptr<MappedFile> file = it->second.lock();
+            // Reuse the mapping unless the file has been replaced since.
+            if (file && file->matches(st.st_dev, st.st_ino, st.st_mtime, static_cast<std::size_t>(st.st_size))) {
+                retain(file);
+                return file;
+            }
+            released.push_back(std::move(file));
+        }
+    }
+
+    // Open and map without holding the lock so slow filesystems only stall
+    // the requests for that file.
+    fd_guard fd(::open(path.c_str(), O_RDONLY));
+    if (fd.fd_ < 0) {
+        return nullptr;
+    }
+
+    // Stat the open descriptor so the recorded identity matches what is mapped.
+    if (::fstat(fd.fd_, &st) != 0 || st.st_size <= 0) {
+        return nullptr;
+    }
+
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.fd_, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>(path,
+                                                                      static_cast<const char*>(data),
+                                                                      size,
+                                                                      st.st_dev,
+                                                                      st.st_ino,
+                                                                      st.st_mtime);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    // Another request may have mapped the same file meanwhile; keep the winner.
+    std::shared_ptr<MappedFile> file = cache[path].lock();
+    if (file && file->matches(mapped->dev_, mapped->ino_, mapped->mtime_, mapped->size_)) {
+        released.push_back(std::move(mapped));
+    } else {
+        released.push_back(std::move(file));
+        file = mapped;
+        cache[path] = file;
+    }
+    retain(file);
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second.expired()) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return file;
+}
+
+MappedFile::MappedFile(std::string const& path,
+                       const char* data,
+                       std::size_t size,
+                       dev_t dev,
+                       ino_t ino,
+                       time_t mtime) :
+    path_(path),
+    data_(data),
+    size_(size),
+    dev_(dev),
+    ino_(ino),
+    mtime_(mtime) {}
+
+MappedFile::~MappedFile()
+{
+    ::munmap(const_cast<char*>(data_), size_);
+}
+
+bool MappedFile::matches(dev_t dev,
+                         ino_t ino,
+                         time_t mtime,
+                         std::size_t size) const
+{
+    return dev_ == dev &&
+           ino_ == ino &&
+           mtime_ == mtime &&
+           size_ == size;
+}
+
+} // ns node_fontnik
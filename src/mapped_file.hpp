@@ -0,0 +1,59 @@
+#ifndef NODE_FONTNIK_MAPPED_FILE_HPP
+#define NODE_FONTNIK_MAPPED_FILE_HPP
+
+// std
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// posix
+#include <sys/types.h>
+
+namespace node_fontnik
+{
+
+// A read-only memory mapping of a font file. Opening a path that is already
+// mapped, and unchanged on disk, returns the existing mapping. Mappings stay
+// alive while a request holds them and the most recently opened few are kept
+// between requests; the rest are unmapped once their last holder releases them.
+//
+// The identity check only decides whether to reuse a mapping. It does not
+// protect a mapping already in use: truncating or rewriting a mapped file in
+// place raises SIGBUS, so font files must be replaced atomically (write a new
+// file, then rename it over the old one).
+class MappedFile
+{
+public:
+    static std::shared_ptr<MappedFile> open(std::string const& path);
+
+    MappedFile(std::string const& path,
+               const char* data,
+               std::size_t size,
+               dev_t dev,
+               ino_t ino,
+               time_t mtime);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    bool matches(dev_t dev,
+                 ino_t ino,
+                 time_t mtime,
+                 std::size_t size) const;
+
+    std::string path_;
+    const char* data_;
+    std::size_t size_;
+    dev_t dev_;
+    ino_t ino_;
+    time_t mtime_;
+};
+
+} // ns node_fontnik
+
+#endif // NODE_FONTNIK_MAPPED_FILE_HPP
@@ -11,6 +11,8 @@ namespace node_fontnik
 NAN_MODULE_INIT(RegisterModule) {
     target->Set(Nan::New("load").ToLocalChecked(), Nan::New<v8::FunctionTemplate>(Load)->GetFunction());
     target->Set(Nan::New("range").ToLocalChecked(), Nan::New<v8::FunctionTemplate>(Range)->GetFunction());
+    target->Set(Nan::New("glyphs").ToLocalChecked(), Nan::New<v8::FunctionTemplate>(Glyphs)->GetFunction());
+    target->Set(Nan::New("hashes").ToLocalChecked(), Nan::New<v8::FunctionTemplate>(Hashes)->GetFunction());
 }
 
 NODE_MODULE(fontnik, RegisterModule);
@@ -35,6 +35,9 @@ test('bin/build-glyphs', function(t) {
                 q.error(err);
                 q.error(stderr);
                 fs.readdir(dir+'/'+buffsize, function(err, files) {
+                    q.ok(files.indexOf('manifest.json') >= 0, 'writes manifest.json');
+                    files = files.filter(function(f) { return f !== 'manifest.json'; });
+
                     var buffsizeno = parseInt(buffsize)||256;
                     var filesno = Math.ceil(65536/buffsizeno);
 
@@ -86,6 +89,36 @@ test('bin/build-glyphs', function(t) {
 
 });
 
+test('bin/build-glyphs rebuild', function(t) {
+    var script = path.normalize(__dirname + '/../bin/build-glyphs'),
+        font = path.normalize(__dirname + '/../fonts/open-sans/OpenSans-Regular.ttf'),
+        dir = bin_output + '/default';
+
+    var changed = dir + '/0-255.pbf',
+        missing = dir + '/256-511.pbf';
+
+    // Tamper with the manifest for one range and delete another range's output.
+    var manifest = JSON.parse(fs.readFileSync(dir + '/manifest.json'));
+    manifest.ranges['0-255'][0].glyphs['65'] = 'stale';
+    fs.writeFileSync(dir + '/manifest.json', JSON.stringify(manifest));
+    fs.unlinkSync(missing);
+
+    var past = new Date(2000, 0, 1);
+    fs.readdirSync(dir).forEach(function(f) {
+        fs.utimesSync(path.join(dir, f), past, past);
+    });
+
+    exec([script, font, dir].join(' '), function(err, stdout, stderr) {
+        t.error(err);
+        t.error(stderr);
+        t.ok(fs.statSync(changed).mtime > past, 'rewrites range with changed hashes');
+        t.ok(fs.existsSync(missing), 'rewrites missing range');
+        t.equal(fs.statSync(dir + '/512-767.pbf').mtime.getTime(), past.getTime(), 'skips unchanged range');
+        t.notEqual(JSON.parse(fs.readFileSync(dir + '/manifest.json')).ranges['0-255'][0].glyphs['65'], 'stale', 'updates manifest');
+        t.end();
+    });
+});
+
 test('bin/font-inspect', function(t) {
     var script = path.normalize(__dirname + '/../bin/font-inspect'),
         opensans = path.normalize(__dirname + '/fixtures/fonts/OpenSans-Regular.ttf'),
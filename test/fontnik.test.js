@@ -26,6 +26,8 @@ var firasans = fs.readFileSync(path.resolve(__dirname + '/../fonts/firasans-medi
 var opensans = fs.readFileSync(path.resolve(__dirname + '/../fonts/open-sans/OpenSans-Regular.ttf'));
 var guardianbold = fs.readFileSync(path.resolve(__dirname + '/../fonts/GuardianTextSansWeb/GuardianTextSansWeb-Bold.ttf'));
 var osaka = fs.readFileSync(path.resolve(__dirname + '/../fonts/osaka/Osaka.ttf'));
+var opensansPath = path.resolve(__dirname + '/../fonts/open-sans/OpenSans-Regular.ttf');
+var collection = fs.readFileSync(path.resolve(__dirname + '/fixtures/collection/OpenSans-FiraSans.ttc'));
 
 test('load', function(t) {
     t.test('loads: Fira Sans', function(t) {
@@ -69,15 +71,110 @@ test('load', function(t) {
         });
     });
 
+    t.test('loads: file path', function(t) {
+        fontnik.load(opensansPath, function(err, faces) {
+            t.error(err);
+            fontnik.load(opensans, function(err, expected) {
+                t.error(err);
+                t.deepEqual(faces, expected);
+                t.end();
+            });
+        });
+    });
+
+    t.test('loads: concurrent file paths', function(t) {
+        var remaining = 4;
+        for (var i = 0; i < 4; i++) {
+            fontnik.load(opensansPath, function(err, faces) {
+                t.error(err);
+                t.equal(faces[0].points.length, 882);
+                if (--remaining === 0) t.end();
+            });
+        }
+    });
+
+    t.test('file path does not exist', function(t) {
+        fontnik.load('/does/not/exist.ttf', function(err, faces) {
+            t.ok(err);
+            t.equal(err.message, 'could not open font file /does/not/exist.ttf');
+            t.end();
+        });
+    });
+
+    t.test('loads: collection', function(t) {
+        fontnik.load(collection, function(err, faces) {
+            t.error(err);
+            t.equal(faces.length, 2);
+            t.equal(faces[0].family_name, 'Open Sans');
+            t.equal(faces[0].points.length, 882);
+            t.equal(faces[1].family_name, 'Fira Sans');
+            t.equal(faces[1].points.length, 789);
+            t.end();
+        });
+    });
+
+    t.test('loads: collection faces', function(t) {
+        fontnik.load(collection, {faces: [1]}, function(err, faces) {
+            t.error(err);
+            t.equal(faces.length, 1);
+            t.equal(faces[0].family_name, 'Fira Sans');
+            t.end();
+        });
+    });
+
+    t.test('loads: optional options', function(t) {
+        fontnik.load(firasans, undefined, function(err, faces) {
+            t.error(err);
+            t.equal(faces[0].family_name, 'Fira Sans');
+            fontnik.load(firasans, null, function(err, faces) {
+                t.error(err);
+                t.equal(faces[0].family_name, 'Fira Sans');
+                fontnik.load(firasans, function(err, faces) {
+                    t.error(err);
+                    t.equal(faces[0].family_name, 'Fira Sans');
+                    t.end();
+                }, 'ignored');
+            });
+        });
+    });
+
+    t.test('loads: collection face out of range', function(t) {
+        fontnik.load(collection, {faces: [0, 2]}, function(err, faces) {
+            t.ok(err);
+            t.equal(err.message, 'font face index out of range');
+            t.end();
+        });
+    });
+
     t.test('invalid arguments', function(t) {
         t.throws(function() {
             fontnik.load();
         }, /First argument must be a font buffer/);
 
+        t.throws(function() {
+            fontnik.load(firasans, 'faces', function(err, faces) {});
+        }, /Second argument must be an object of options/);
+
+        t.throws(function() {
+            fontnik.load(firasans, {faces: [-1]}, function(err, faces) {});
+        }, /option `faces` must be an array of face indices from 0-65535/);
+
+        t.throws(function() {
+            fontnik.load(firasans, {faces: []}, function(err, faces) {});
+        }, /option `faces` must be an array of face indices from 0-65535/);
+
+        t.throws(function() {
+            fontnik.load(firasans, {faces: [0]});
+        }, /Callback must be a function/);
+
         t.throws(function() {
             fontnik.load({});
         }, /First argument must be a font buffer/);
 
+        t.throws(function() {
+            fontnik.load('');
+        }, /Font path must be a non-empty string/);
+
         t.end();
     });
 
@@ -156,15 +253,87 @@ test('range', function(t) {
         });
     });
 
+    t.test('range gzip encoding', function(t) {
+        fontnik.range({font: opensans, start: 0, end: 256}, function(err, raw) {
+            t.error(err);
+            fontnik.range({font: opensans, start: 0, end: 256, encoding: 'gzip'}, function(err, res) {
+                t.error(err);
+                t.equal(res[0], 0x1f);
+                t.equal(res[1], 0x8b);
+                zlib.gunzip(res, function(err, inflated) {
+                    t.error(err);
+                    t.deepEqual(inflated, raw);
+                    t.end();
+                });
+            });
+        });
+    });
+
+    t.test('range deflate encoding', function(t) {
+        fontnik.range({font: opensans, start: 0, end: 256, encoding: 'deflate'}, function(err, res) {
+            t.error(err);
+            zlib.inflate(res, function(err, inflated) {
+                t.error(err);
+                t.deepEqual(inflated, data);
+                t.end();
+            });
+        });
+    });
+
+    t.test('range metrics_only', function(t) {
+        fontnik.range({font: opensans, start: 0, end: 256}, function(err, full) {
+            t.error(err);
+            fontnik.range({font: opensans, start: 0, end: 256, metrics_only: true}, function(err, res) {
+                t.error(err);
+                var expected = new Glyphs(new Protobuf(new Uint8Array(full))).stacks['Open Sans Regular'];
+                var actual = new Glyphs(new Protobuf(new Uint8Array(res))).stacks['Open Sans Regular'];
+                t.equal(actual.range, expected.range);
+                t.deepEqual(Object.keys(actual.glyphs), Object.keys(expected.glyphs));
+                Object.keys(actual.glyphs).forEach(function(id) {
+                    t.equal(actual.glyphs[id].hasOwnProperty('bitmap'), false);
+                    t.deepEqual(actual.glyphs[id], JSON.parse(JSON.stringify(expected.glyphs[id], nobuffer)));
+                });
+                t.end();
+            });
+        });
+    });
+
+    t.test('range collection', function(t) {
+        fontnik.range({font: collection, start: 0, end: 256}, function(err, res) {
+            t.error(err);
+            var vt = new Glyphs(new Protobuf(new Uint8Array(res)));
+            t.deepEqual(Object.keys(vt.stacks), ['Open Sans Regular', 'Fira Sans Medium']);
+            fontnik.range({font: opensans, start: 0, end: 256}, function(err, single) {
+                t.error(err);
+                var expected = new Glyphs(new Protobuf(new Uint8Array(single)));
+                t.deepEqual(vt.stacks['Open Sans Regular'], expected.stacks['Open Sans Regular']);
+                t.end();
+            });
+        });
+    });
+
+    t.test('range collection faces', function(t) {
+        fontnik.range({font: collection, start: 0, end: 256, faces: [1]}, function(err, res) {
+            t.error(err);
+            var vt = new Glyphs(new Protobuf(new Uint8Array(res)));
+            t.deepEqual(Object.keys(vt.stacks), ['Fira Sans Medium']);
+            t.end();
+        });
+    });
+
     t.test('invalid arguments', function(t) {
         t.throws(function() {
             fontnik.range();
         }, /First argument must be an object of options/);
 
         t.throws(function() {
-            fontnik.range({font:'not an object'}, function(err, data) {});
+            fontnik.range({font: 1}, function(err, data) {});
         }, /Font buffer is not an object/);
 
+        t.throws(function() {
+            fontnik.range({font: '', start: 0, end: 256}, function(err, data) {});
+        }, /Font path must be a non-empty string/);
+
         t.throws(function() {
             fontnik.range({font:{}}, function(err, data) {});
         }, /First argument must be a font buffer/);
@@ -172,6 +341,30 @@ test('range', function(t) {
         t.end();
     });
 
+    t.test('range file path', function(t) {
+        fontnik.range({font: opensansPath, start: 0, end: 256}, function(err, res) {
+            t.error(err);
+            t.deepEqual(res, data);
+            t.end();
+        });
+    });
+
+    t.test('range file path not a font', function(t) {
+        fontnik.range({font: __filename, start: 0, end: 256}, function(err, res) {
+            t.ok(err);
+            t.equal(err.message, 'could not open font');
+            t.end();
+        });
+    });
+
+    t.test('range file path does not exist', function(t) {
+        fontnik.range({font: 'not a path', start: 0, end: 256}, function(err, res) {
+            t.ok(err);
+            t.equal(err.message, 'could not open font file not a path');
+            t.end();
+        });
+    });
+
     t.test('range filepath does not exist', function(t) {
         var doesnotexistsans = new Buffer('baloney');
         fontnik.range({font: doesnotexistsans, start: 0, end: 256}, function(err, faces) {
@@ -201,6 +394,36 @@ test('range', function(t) {
         t.end();
     });
 
+    t.test('range typeerror encoding', function(t) {
+        t.throws(function() {
+            fontnik.range({font: opensans, start: 0, end: 256, encoding: 'br'}, function(err, data) {});
+        }, /option `encoding` must be 'gzip' or 'deflate'/);
+        t.throws(function() {
+            fontnik.range({font: opensans, start: 0, end: 256, encoding: 1}, function(err, data) {});
+        }, /option `encoding` must be 'gzip' or 'deflate'/);
+        t.end();
+    });
+
+    t.test('range typeerror metrics_only', function(t) {
+        t.throws(function() {
+            fontnik.range({font: opensans, start: 0, end: 256, metrics_only: 'yes'}, function(err, data) {});
+        }, /option `metrics_only` must be a boolean/);
+        t.end();
+    });
+
+    t.test('range typeerror faces', function(t) {
+        t.throws(function() {
+            fontnik.range({font: opensans, start: 0, end: 256, faces: 0}, function(err, data) {});
+        }, /option `faces` must be an array of face indices from 0-65535/);
+        t.throws(function() {
+            fontnik.range({font: opensans, start: 0, end: 256, faces: ['x']}, function(err, data) {});
+        }, /option `faces` must be an array of face indices from 0-65535/);
+        t.throws(function() {
+            fontnik.range({font: opensans, start: 0, end: 256, faces: []}, function(err, data) {});
+        }, /option `faces` must be an array of face indices from 0-65535/);
+        t.end();
+    });
+
     t.test('range typeerror lt', function(t) {
         t.throws(function() {
             fontnik.range({font: opensans, start: 256, end: 0}, function(err, data) {});
@@ -248,3 +471,145 @@ test('range', function(t) {
         });
     });
 });
+
+test('glyphs', function(t) {
+    t.test('glyphs', function(t) {
+        fontnik.range({font: opensans, start: 0, end: 256}, function(err, full) {
+            t.error(err);
+            fontnik.glyphs({font: opensans, codepoints: [66, 65, 200, 66]}, function(err, res) {
+                t.error(err);
+                var expected = new Glyphs(new Protobuf(new Uint8Array(full))).stacks['Open Sans Regular'];
+                var actual = new Glyphs(new Protobuf(new Uint8Array(res))).stacks['Open Sans Regular'];
+                t.equal(actual.range, '65-200');
+                t.deepEqual(Object.keys(actual.glyphs), ['65', '66', '200']);
+                Object.keys(actual.glyphs).forEach(function(id) {
+                    t.deepEqual(actual.glyphs[id].bitmap, expected.glyphs[id].bitmap);
+                    t.equal(actual.glyphs[id].advance, expected.glyphs[id].advance);
+                });
+                t.end();
+            });
+        });
+    });
+
+    t.test('glyphs gzip encoding', function(t) {
+        fontnik.glyphs({font: opensans, codepoints: [65], encoding: 'gzip'}, function(err, res) {
+            t.error(err);
+            zlib.gunzip(res, function(err, inflated) {
+                t.error(err);
+                var vt = new Glyphs(new Protobuf(new Uint8Array(inflated)));
+                t.deepEqual(Object.keys(vt.stacks['Open Sans Regular'].glyphs), ['65']);
+                t.end();
+            });
+        });
+    });
+
+    t.test('invalid arguments', function(t) {
+        t.throws(function() {
+            fontnik.glyphs();
+        }, /First argument must be an object of options/);
+
+        t.throws(function() {
+            fontnik.glyphs({font:{}, codepoints: [65]}, function(err, data) {});
+        }, /First argument must be a font buffer/);
+
+        t.throws(function() {
+            fontnik.glyphs({font: opensans}, function(err, data) {});
+        }, /option `codepoints` must be a non-empty array of numbers from 0-65535/);
+
+        t.throws(function() {
+            fontnik.glyphs({font: opensans, codepoints: []}, function(err, data) {});
+        }, /option `codepoints` must be a non-empty array of numbers from 0-65535/);
+
+        t.throws(function() {
+            fontnik.glyphs({font: opensans, codepoints: [65, 70000]}, function(err, data) {});
+        }, /option `codepoints` must be a non-empty array of numbers from 0-65535/);
+
+        t.throws(function() {
+            fontnik.glyphs({font: opensans, codepoints: [NaN]}, function(err, data) {});
+        }, /option `codepoints` must be a non-empty array of numbers from 0-65535/);
+
+        t.throws(function() {
+            fontnik.glyphs({font: opensans, codepoints: [65.5]}, function(err, data) {});
+        }, /option `codepoints` must be a non-empty array of numbers from 0-65535/);
+
+        t.throws(function() {
+            fontnik.glyphs({font: opensans, codepoints: [65]});
+        }, /Callback must be a function/);
+        t.end();
+    });
+});
+
+test('hashes', function(t) {
+    t.test('hashes', function(t) {
+        fontnik.hashes({font: opensans, start: 0, end: 256}, function(err, faces) {
+            t.error(err);
+            t.equal(faces.length, 1);
+            t.equal(faces[0].family_name, 'Open Sans');
+            t.equal(faces[0].style_name, 'Regular');
+            t.ok(/^[0-9a-f]{16}$/.test(faces[0].glyphs['65']));
+            t.notEqual(faces[0].glyphs['65'], faces[0].glyphs['66']);
+            t.equal(faces[0].glyphs.hasOwnProperty('0'), false, 'skips missing glyphs');
+            fontnik.hashes({font: opensans, start: 65, end: 65}, function(err, again) {
+                t.error(err);
+                t.deepEqual(Object.keys(again[0].glyphs), ['65']);
+                t.equal(again[0].glyphs['65'], faces[0].glyphs['65'], 'stable across calls');
+                t.end();
+            });
+        });
+    });
+
+    t.test('hashes match range coverage', function(t) {
+        fontnik.range({font: opensans, start: 0, end: 256}, function(err, res) {
+            t.error(err);
+            var vt = new Glyphs(new Protobuf(new Uint8Array(res)));
+            fontnik.hashes({font: opensans, start: 0, end: 256}, function(err, faces) {
+                t.error(err);
+                t.deepEqual(Object.keys(faces[0].glyphs), Object.keys(vt.stacks['Open Sans Regular'].glyphs));
+                t.end();
+            });
+        });
+    });
+
+    t.test('hashes collection faces', function(t) {
+        fontnik.hashes({font: collection, start: 65, end: 65, faces: [1]}, function(err, faces) {
+            t.error(err);
+            t.equal(faces.length, 1);
+            t.equal(faces[0].family_name, 'Fira Sans');
+            fontnik.hashes({font: firasans, start: 65, end: 65}, function(err, fira) {
+                t.error(err);
+                t.deepEqual(faces, fira);
+                t.end();
+            });
+        });
+    });
+
+    t.test('hashes differ between fonts', function(t) {
+        fontnik.hashes({font: firasans, start: 65, end: 65}, function(err, fira) {
+            t.error(err);
+            fontnik.hashes({font: opensans, start: 65, end: 65}, function(err, open) {
+                t.error(err);
+                t.notEqual(fira[0].glyphs['65'], open[0].glyphs['65']);
+                t.end();
+            });
+        });
+    });
+
+    t.test('invalid arguments', function(t) {
+        t.throws(function() {
+            fontnik.hashes();
+        }, /First argument must be an object of options/);
+
+        t.throws(function() {
+            fontnik.hashes({font:{}, start: 0, end: 256}, function(err, data) {});
+        }, /First argument must be a font buffer/);
+
+        t.throws(function() {
+            fontnik.hashes({font: opensans, start: 256, end: 0}, function(err, data) {});
+        }, /`start` must be less than or equal to `end`/);
+
+        t.throws(function() {
+            fontnik.hashes({font: opensans, start: 0, end: 256});
+        }, /Callback must be a function/);
+        t.end();
+    });
+});